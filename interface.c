@@ -1,39 +1,184 @@
 #include "interface.h"
 #include "vmm.h"
+#include "swap.h"
 
 // Interface implementation
 // Implement APIs here...
 
 // Global variables
-QUEUE* queue;
+ARBITER* arbiter;
+SWAP* swap;
 int managerPolicy;
 int pageSize;
-int numFrames;
-void* vm_ptr;
 
 
 void mm_init(enum policy_type policy, void *vm, int vm_size, int num_frames, int page_size) {   
     // initialize global variables
     struct sigaction sa;
     sa.sa_flags = SA_SIGINFO;
-    numFrames = num_frames;
     managerPolicy = policy;
     pageSize = page_size;
-    vm_ptr = vm;
     int protCheck;
 
+#ifdef MM_POLICY
+    // a policy-specialized build only contains the fault path of its own policy
+    if(policy != MM_POLICY) {
+        fprintf(stderr, "%s: this build only supports replacement policy %d\n", __func__, MM_POLICY);
+        exit(EXIT_FAILURE);
+    }
+#endif
+
     // link segfaults to our segfault handler
     sa.sa_sigaction = sigsegv_handler;
     sigaction(SIGSEGV, &sa, NULL);
 
-    // initialize the queue to store pages
-    queue = init_queue();
+    // initialize the arbiter sharing the frames, with the given memory as its first region
+    arbiter = init_arbiter(num_frames);
+    arbiter_add_region(arbiter, vm, vm_size / page_size, 0, 1);
+
+    // initialize the swap evicted pages are written to, without it pages keep their memory
+    swap = init_swap(page_size);
 
     // set the protection on the virtual memory to none so that a fault occurs on any access
     protCheck = mprotect(vm, vm_size, PROT_NONE);
 }
 
 
+int mm_add_region(void *vm, int vm_size, int min_frames, int weight) {
+    int totalMin = (min_frames > 1) ? min_frames : 1;
+    int i;
+
+    // the region must be page aligned, must not overlap another region
+    // and the min guarantees of all regions, at least one frame each, must fit in the frames
+    if((vm == NULL) || (((uintptr_t)vm % pageSize) != 0) || (vm_size < pageSize)) {
+        return -1;
+    }
+    if((min_frames < 0) || (weight <= 0)) {
+        return -1;
+    }
+    for(i = 0; i < arbiter->numRegions; i++) {
+        REGION* region = arbiter->regions[i];
+        if(((char*)vm < (char*)region->vm_ptr + (region->numPages * pageSize)) &&
+           ((char*)region->vm_ptr < (char*)vm + vm_size)) {
+            return -1;
+        }
+        totalMin += quota_floor(region);
+    }
+    if(totalMin > arbiter->numFrames) {
+        return -1;
+    }
+
+    if(arbiter_add_region(arbiter, vm, vm_size / pageSize, min_frames, weight) == NULL) {
+        return -1;
+    }
+
+    // set the protection on the virtual memory to none so that a fault occurs on any access
+    mprotect(vm, vm_size, PROT_NONE);
+    return 0;
+}
+
+
+void mm_set_scope(enum scope_type scope) {
+    // an unknown scope leaves the current one in place
+    if((scope != MM_GLOBAL) && (scope != MM_LOCAL)) {
+        fprintf(stderr, "%s: unknown replacement scope %d\n", __func__, scope);
+        return;
+    }
+    arbiter->scope = scope;
+}
+
+
+int mm_region_stats(void *vm, int *faults, int *write_backs, int *frames) {
+    REGION* region = find_region(arbiter, vm, pageSize);
+
+    if((region == NULL) || (region->vm_ptr != vm)) {
+        return -1;
+    }
+
+    *faults = region->faults;
+    *write_backs = region->writebacks;
+    *frames = region->queue->size;
+    return 0;
+}
+
+
+int mm_advise(void *vm, void *addr, int len, enum advice_type hint) {
+    int firstPage;
+    int lastPage;
+    int pageNum;
+    char* pageAddr;
+    PAGE* page;
+    REGION* evictedRegion;
+    REGION* region = find_region(arbiter, vm, pageSize);
+
+    // the hinted range must be a non-empty part of a managed region
+    if((region == NULL) || (region->vm_ptr != vm) || (len <= 0) || ((char*)addr < (char*)vm)) {
+        return -1;
+    }
+    if((hint < MM_ADV_NORMAL) || (hint > MM_ADV_HOT)) {
+        return -1;
+    }
+    firstPage = ((char*)addr - (char*)vm) / pageSize;
+    lastPage = ((char*)addr + len - 1 - (char*)vm) / pageSize;
+    if(lastPage >= region->numPages) {
+        return -1;
+    }
+
+    for(pageNum = firstPage; pageNum <= lastPage; pageNum++) {
+        pageAddr = (char*)vm + (pageNum * pageSize);
+        page = find_in_queue(region->queue, pageNum, managerPolicy);
+
+        switch (hint)
+        {
+        case MM_ADV_WILLNEED:
+            // Prefault the page as if it was read, but only into free frames the region
+            // may use so that no resident page is evicted for a speculative one
+            if((page == NULL) && (region->queue->size < region_frame_limit(arbiter, region))) {
+                page = init_page(pageNum);
+                page->advice = region->pageAdvice[pageNum];
+#ifdef WITH_THIRD_CHANCE
+                page->referenced = 1;
+                page->canRead = true;
+#endif
+                arbiter_insert(arbiter, region, page, &evictedRegion, pageSize, managerPolicy);
+                if(swap != NULL) {
+                    swap_in(swap, region, pageNum);
+                }
+                mprotect(pageAddr, pageSize, PROT_READ);
+            }
+            break;
+        case MM_ADV_DONTNEED:
+            // Drop the page and its contents, its frame is freed without a write-back
+            if(page != NULL) {
+                queue_remove(region->queue, page, managerPolicy);
+                release_frame(arbiter, page->frameNum);
+                free(page);
+            }
+            swap_drop(region, pageNum);
+            // Releasing the memory zeroes it without bringing released pages back in
+            madvise(pageAddr, pageSize, MADV_DONTNEED);
+            mprotect(pageAddr, pageSize, PROT_NONE);
+            break;
+        case MM_ADV_NORMAL:
+        case MM_ADV_SEQUENTIAL:
+        case MM_ADV_HOT:
+            // Remember the hint for future faults and apply it to the resident page
+            region->pageAdvice[pageNum] = hint;
+            if(page != NULL) {
+                count_advice(region->queue, page->advice, -1);
+                page->advice = hint;
+                count_advice(region->queue, page->advice, 1);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    return 0;
+}
+
+
 void sigsegv_handler(int sig, siginfo_t* info, void* ucontext){
     int faultType;
     int pageNum;
@@ -45,16 +190,28 @@ void sigsegv_handler(int sig, siginfo_t* info, void* ucontext){
     PAGE* evictedPage;
     int evictedPageNum;
     int writeback;
+    REGION* region;
+    REGION* evictedRegion;
+    char* vm_ptr;
 
     // Get address of fault
     virtAddr = (char*)info->si_addr;
 
+    // Find the region the fault occured in
+    region = find_region(arbiter, virtAddr, pageSize);
+    if(region == NULL) {
+        // Not a managed address, so let the access fault again with the default action
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+    vm_ptr = region->vm_ptr;
+
     // Get page in which the fault occured
-    pageNum = (virtAddr - (char*)vm_ptr) / pageSize;
-    offset = (virtAddr - (char*)vm_ptr)% pageSize;
+    pageNum = (virtAddr - vm_ptr) / pageSize;
+    offset = (virtAddr - vm_ptr)% pageSize;
     
     // Figure out page is already in the queue
-    referencedPage = find_in_queue(queue, pageNum, managerPolicy);
+    referencedPage = find_in_queue(region->queue, pageNum, managerPolicy);
 
     if(referencedPage != NULL) {
         physAddr = referencedPage->frameNum * pageSize + offset;
@@ -64,13 +221,17 @@ void sigsegv_handler(int sig, siginfo_t* info, void* ucontext){
     // Else, page is not in queue so create one
     else {
         newPage = init_page(pageNum);
+        newPage->advice = region->pageAdvice[pageNum];
+#ifdef WITH_THIRD_CHANCE
         newPage->referenced = 1;
-        evictedPage = queue_insert(queue, newPage, numFrames, vm_ptr, pageSize, managerPolicy);
+#endif
+        account_fault(arbiter, region);
+        evictedPage = arbiter_insert(arbiter, region, newPage, &evictedRegion, pageSize, managerPolicy);
         // If we did not evict a page becuase queue is not full
         if(evictedPage == NULL) {
-            // If the queue is not yet full
-            // Before the Queue is filled, the frames are in order so we can use queue size
-            physAddr = (queue->size - 1) * pageSize + offset; 
+            // If the region could take a free frame
+            // The arbiter handed the page that frame when it was inserted
+            physAddr = newPage->frameNum * pageSize + offset; 
             evictedPageNum = -1;
             writeback = 0;
         }
@@ -80,40 +241,57 @@ void sigsegv_handler(int sig, siginfo_t* info, void* ucontext){
             physAddr = evictedPage->frameNum * pageSize + offset;
             evictedPageNum = evictedPage->pageNum;
             writeback = evictedPage->modified;
+            // Stage the evicted page's write-back, it completes while the new page is brought in
+            if(swap != NULL) {
+                swap_out(swap, evictedRegion, evictedPage);
+            }
             // Protect evicted pages virtual address with PROT_NONE so we get a signal if its referenced again
-            mprotect((char*)vm_ptr + (evictedPageNum * pageSize), pageSize, PROT_NONE);
+            // The evicted page may belong to another region
+            mprotect((char*)evictedRegion->vm_ptr + (evictedPageNum * pageSize), pageSize, PROT_NONE);
         }
     }
 
+    // Bring the new page's contents back from swap
+    if((newPage != NULL) && (swap != NULL)) {
+        swap_in(swap, region, pageNum);
+    }
+
     // Get the type of fault by using ucontext struct to access ERR register
     ucontext_t* context = (ucontext_t*) ucontext;
-    faultType = get_fault_type(context, queue, referencedPage, managerPolicy);
+    faultType = get_fault_type(context, region->queue, referencedPage, managerPolicy);
     switch (faultType)
     {
     case READ_FAULT:
         // Fault type: Read access to a non-present page
         // So, set the protection to read and set the referenced bit
         mprotect((char*)vm_ptr + (pageNum * pageSize), pageSize, PROT_READ);
+#ifdef WITH_THIRD_CHANCE
         newPage->canRead = true;
         newPage->referenced = 1;
+#endif
         break;
     case WRITE_FAULT:
         // Fault type: Write access to a non-present page
         // So, set the protection to read/wrtie and set the referenced/modified bits
         mprotect((char*)vm_ptr + (pageNum * pageSize), pageSize, PROT_READ | PROT_WRITE);
+#ifdef WITH_THIRD_CHANCE
         newPage->canWrite = true;
         newPage->canRead = true;
         newPage->referenced = 1;
+#endif
         newPage->modified = 1;
         break;
     case PERM_FAULT:
         // Fault type: Write access to a currently Read-only page
         // So, update the protection to be read/write and set the referenced/modified bits 
         mprotect((char*)vm_ptr + (pageNum * pageSize), pageSize, PROT_READ | PROT_WRITE);
+#ifdef WITH_THIRD_CHANCE
         referencedPage->canWrite = true;
         referencedPage->referenced = 1;
+#endif
         referencedPage->modified = 1;
         break;
+#ifdef WITH_THIRD_CHANCE
     case TRACK_READ_FAULT:
         // Fault type: Track a "read" reference to the page that has Read and/or Write permissions on
         // So, update the the protection to read and reset the refernced bit and the third chance
@@ -129,6 +307,7 @@ void sigsegv_handler(int sig, siginfo_t* info, void* ucontext){
         referencedPage->modified = 1;
         referencedPage->thirdChanceTaken = false;
         break;
+#endif
     default:
         break;
     }
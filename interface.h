@@ -21,9 +21,34 @@ enum policy_type
     MM_THIRD = 2, // Third Chance Replacement Policy
 };
 
+// Replacement scope type
+enum scope_type
+{
+    MM_GLOBAL = 1, // Victims are picked across all regions by cost
+    MM_LOCAL = 2,  // Each region replaces within its own quota of frames
+};
+
+// Access hint type
+enum advice_type
+{
+    MM_ADV_NORMAL = 0,     // No special treatment, clears a previous hint
+    MM_ADV_WILLNEED = 1,   // Prefault the range into free frames
+    MM_ADV_DONTNEED = 2,   // Drop the range without write-back
+    MM_ADV_SEQUENTIAL = 3, // Range is scanned once, evict pages behind the scan first
+    MM_ADV_HOT = 4,        // Range is reused heavily, keep it resident over other pages
+};
+
 // APIs
 void mm_init(enum policy_type policy, void *vm, int vm_size, int num_frames, int page_size);
 
+int mm_add_region(void *vm, int vm_size, int min_frames, int weight);
+
+void mm_set_scope(enum scope_type scope);
+
+int mm_region_stats(void *vm, int *faults, int *write_backs, int *frames);
+
+int mm_advise(void *vm, void *addr, int len, enum advice_type hint);
+
 void mm_logger(int virt_page, int fault_type, int evicted_page, int write_back, unsigned int phy_addr);
 
 void sigsegv_handler(int sig, siginfo_t* info, void* ucontext);
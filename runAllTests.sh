@@ -37,3 +37,22 @@ do
     done
 done
 
+
+# compares the policy-specialized builds with sample outputs
+make fifo third
+for policy in 1 2 
+do
+    if [ $policy -eq 1 ]; then build=./proj3_fifo; else build=./proj3_third; fi
+    for numFrames in 1 4 5 8 12 16
+    do
+        for inputNum in {1..12}
+        do
+            echo Testing:  Build=$build  Policy=$policy  NumFrames=$numFrames  Input=$inputNum
+            $build $policy $numFrames sample_input/input_$inputNum
+            diff output/result-$policy-$numFrames-input_$inputNum sample_output/result-$policy-$numFrames-input_$inputNum
+        done
+    done
+done
+
+# runs the driver tests of the manager's API
+make test
@@ -0,0 +1,634 @@
+#include <sys/syscall.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "swap.h"
+
+// Swap pipeline implementation
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : init_swap
+// Description  : Initializes the swap file and the io_uring used for swap I/O.
+//                  If io_uring is not available, a thread pool doing pread/pwrite
+//                  is started instead.
+//
+//
+// Inputs       : int pageSize - the size of memory for each page
+// Outputs      : Returns the created swap, null if failed
+
+SWAP* init_swap(int pageSize){
+    // The swap is mapped rather than taken from the heap, so nothing of it sits after the managed memory
+    // and freeing that memory can hand it back without writing into its protected pages
+    SWAP* swap = mmap(NULL, sizeof(SWAP), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(swap == MAP_FAILED) {
+        return NULL;
+    }
+    swap->fd = open(P_tmpdir, O_TMPFILE | O_RDWR, S_IRUSR | S_IWUSR);
+    if(swap->fd < 0) {
+        munmap(swap, sizeof(SWAP));
+        return NULL;
+    }
+
+    swap->pageSize = pageSize;
+    swap->nextSlot = 0;
+    swap->numThreads = 0;
+    for (int i = 0; i < 2; i++){
+        swap->batches[i].buffer = MAP_FAILED;
+    }
+    for (int i = 0; i < 2; i++){
+        swap->batches[i].buffer = mmap(NULL, pageSize * SWAP_BATCH_PAGES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (swap->batches[i].buffer == MAP_FAILED){
+            destroy_swap(swap);
+            return NULL;
+        }
+        swap->batches[i].count = 0;
+        swap->batches[i].pending = 0;
+        swap->batches[i].failed = false;
+    }
+    swap->staging = &swap->batches[0];
+    swap->writing = &swap->batches[1];
+    swap->toSubmit = 0;
+    swap->workHead = NULL;
+    swap->workTail = NULL;
+
+#ifdef SWAP_NO_URING
+    swap->useRing = false;
+#else
+    swap->useRing = init_ring(swap);
+#endif
+
+    if (!swap->useRing){
+        pthread_mutex_init(&swap->lock, NULL);
+        pthread_cond_init(&swap->workReady, NULL);
+        pthread_cond_init(&swap->workDone, NULL);
+        for (int i = 0; i < SWAP_THREADS; i++){
+            if (pthread_create(&swap->threads[swap->numThreads], NULL, swap_worker, swap) == 0){
+                swap->numThreads ++;
+            }
+        }
+        // Without a worker no I/O would ever complete
+        if (swap->numThreads == 0){
+            pthread_mutex_destroy(&swap->lock);
+            pthread_cond_destroy(&swap->workReady);
+            pthread_cond_destroy(&swap->workDone);
+            destroy_swap(swap);
+            return NULL;
+        }
+    }
+
+    return swap;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : destroy_swap
+// Description  : Releases a swap whose setup failed: its batch buffers, swap
+//                  file and the swap itself
+//
+//
+// Inputs       : SWAP* swap - swap instance, without an io_uring or threads
+// Outputs      : None
+
+void destroy_swap(SWAP* swap){
+    for (int i = 0; i < 2; i++){
+        if (swap->batches[i].buffer != MAP_FAILED){
+            munmap(swap->batches[i].buffer, swap->pageSize * SWAP_BATCH_PAGES);
+        }
+    }
+    close(swap->fd);
+    munmap(swap, sizeof(SWAP));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : init_ring
+// Description  : Sets up the io_uring used to submit swap I/O and maps its
+//                  submission and completion queues
+//
+//
+// Inputs       : SWAP* swap - swap instance
+// Outputs      : Returns true if the io_uring can be used
+
+bool init_ring(SWAP* swap){
+    struct io_uring_params params;
+    char* sqRing;
+    char* cqRing;
+    size_t sqRingSize, cqRingSize, sqesSize;
+
+    memset(&params, 0, sizeof(params));
+    swap->ringFd = syscall(__NR_io_uring_setup, SWAP_RING_ENTRIES, &params);
+    if (swap->ringFd < 0){
+        return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, swap->ringFd, IORING_OFF_SQ_RING);
+    cqRing = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, swap->ringFd, IORING_OFF_CQ_RING);
+    swap->sqes = mmap(NULL, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, swap->ringFd, IORING_OFF_SQES);
+    if ((sqRing == MAP_FAILED) || (cqRing == MAP_FAILED) || (swap->sqes == MAP_FAILED)){
+        // Unmap whatever was mapped, the thread pool is used instead
+        if (sqRing != MAP_FAILED){
+            munmap(sqRing, sqRingSize);
+        }
+        if (cqRing != MAP_FAILED){
+            munmap(cqRing, cqRingSize);
+        }
+        if (swap->sqes != MAP_FAILED){
+            munmap(swap->sqes, sqesSize);
+        }
+        close(swap->ringFd);
+        return false;
+    }
+
+    swap->sqHead = (unsigned*)(sqRing + params.sq_off.head);
+    swap->sqTail = (unsigned*)(sqRing + params.sq_off.tail);
+    swap->sqMask = (unsigned*)(sqRing + params.sq_off.ring_mask);
+    swap->sqArray = (unsigned*)(sqRing + params.sq_off.array);
+    swap->cqHead = (unsigned*)(cqRing + params.cq_off.head);
+    swap->cqTail = (unsigned*)(cqRing + params.cq_off.tail);
+    swap->cqMask = (unsigned*)(cqRing + params.cq_off.ring_mask);
+    swap->cqes = (struct io_uring_cqe*)(cqRing + params.cq_off.cqes);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : swap_worker
+// Description  : Thread pool worker doing the queued swap I/O with pread/pwrite
+//
+//
+// Inputs       : void* arg - the swap instance
+// Outputs      : Never returns
+
+void* swap_worker(void* arg){
+    SWAP* swap = (SWAP*) arg;
+    SWAP_IO* io;
+    ssize_t result;
+
+    while (true){
+        pthread_mutex_lock(&swap->lock);
+        while (swap->workHead == NULL){
+            pthread_cond_wait(&swap->workReady, &swap->lock);
+        }
+        io = swap->workHead;
+        swap->workHead = io->next;
+        if (swap->workHead == NULL){
+            swap->workTail = NULL;
+        }
+        pthread_mutex_unlock(&swap->lock);
+
+        if (io->write){
+            result = pwritev(swap->fd, io->iov, io->iovcnt, io->offset);
+        } else {
+            result = preadv(swap->fd, io->iov, io->iovcnt, io->offset);
+        }
+
+        pthread_mutex_lock(&swap->lock);
+        complete_io(swap, io, result);
+        pthread_cond_broadcast(&swap->workDone);
+        pthread_mutex_unlock(&swap->lock);
+    }
+
+    return NULL;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : swap_slot
+// Description  : Returns the swap slot of a page. Slots are allocated a cluster
+//                  of SWAP_CLUSTER_PAGES at a time, so neighbouring virtual pages
+//                  get sequential slots and can be written or read together.
+//
+//
+// Inputs       : SWAP* swap - swap instance
+//              : REGION* region - region the page belongs to
+//              : int pageNum - pageNum of the page
+// Outputs      : Returns the slot number
+
+int swap_slot(SWAP* swap, REGION* region, int pageNum){
+    int cluster = pageNum / SWAP_CLUSTER_PAGES;
+
+    if (region->swapClusters[cluster] < 0){
+        region->swapClusters[cluster] = swap->nextSlot;
+        swap->nextSlot += SWAP_CLUSTER_PAGES;
+    }
+
+    return region->swapClusters[cluster] + (pageNum % SWAP_CLUSTER_PAGES);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : swap_out
+// Description  : Stages an evicted dirty page for write-back and releases the
+//                  page's memory. The write-back is submitted once the batch is
+//                  full, so it overlaps with the page-ins of later faults.
+//                  A clean page is only released if swap holds its contents.
+//
+//
+// Inputs       : SWAP* swap - swap instance
+//              : REGION* region - region the page belongs to
+//              : PAGE* page - the evicted page
+// Outputs      : None
+
+void swap_out(SWAP* swap, REGION* region, PAGE* page){
+    char* pageAddr = (char*)region->vm_ptr + (page->pageNum * swap->pageSize);
+    int* state = &region->swapState[page->pageNum];
+    SWAP_BATCH* batch;
+    int slot;
+    int index;
+
+    if (!page->modified){
+        if (*state != SWAP_NONE){
+            madvise(pageAddr, swap->pageSize, MADV_DONTNEED);
+        }
+        return;
+    }
+
+    slot = swap_slot(swap, region, page->pageNum);
+    batch = find_staged_batch(swap, slot, &index);
+    if (batch == swap->writing){
+        // an older copy of the page is being written, let it finish before writing the slot again
+        wait_batch(swap, batch);
+        batch = NULL;
+    }
+    if (batch == NULL){
+        index = swap->staging->count;
+        swap->staging->slots[index] = slot;
+        swap->staging->states[index] = state;
+        swap->staging->count ++;
+    }
+
+    mprotect(pageAddr, swap->pageSize, PROT_READ);
+    memcpy(swap->staging->buffer + (index * swap->pageSize), pageAddr, swap->pageSize);
+    madvise(pageAddr, swap->pageSize, MADV_DONTNEED);
+    *state = SWAP_STAGED;
+
+    if (swap->staging->count == SWAP_BATCH_PAGES){
+        submit_batch(swap);
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : swap_in
+// Description  : Brings the contents of a page back from swap. A page still
+//                  staged for write-back is copied from the batch, otherwise it
+//                  is read from its slot. The page is left read/write for the
+//                  caller to set its final protection.
+//
+//
+// Inputs       : SWAP* swap - swap instance
+//              : REGION* region - region the page belongs to
+//              : int pageNum - pageNum of the page
+// Outputs      : None
+
+void swap_in(SWAP* swap, REGION* region, int pageNum){
+    char* pageAddr = (char*)region->vm_ptr + (pageNum * swap->pageSize);
+    int state = region->swapState[pageNum];
+    int slot;
+    int index;
+    SWAP_BATCH* batch;
+    SWAP_IO io;
+    struct iovec iov;
+
+    if (state == SWAP_NONE){
+        return;
+    }
+
+    slot = swap_slot(swap, region, pageNum);
+    mprotect(pageAddr, swap->pageSize, PROT_READ | PROT_WRITE);
+
+    if (state == SWAP_STAGED){
+        batch = find_staged_batch(swap, slot, &index);
+        memcpy(pageAddr, batch->buffer + (index * swap->pageSize), swap->pageSize);
+        return;
+    }
+
+    iov.iov_base = pageAddr;
+    iov.iov_len = swap->pageSize;
+    io.write = false;
+    io.iov = &iov;
+    io.iovcnt = 1;
+    io.offset = (off_t)slot * swap->pageSize;
+    io.batch = NULL;
+    submit_io(swap, &io);
+    wait_io(swap, &io);
+    if (io.result != swap->pageSize){
+        fprintf(stderr, "%s: swap read of page %d failed\n", __func__, pageNum);
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : swap_drop
+// Description  : Forgets the swapped contents of a page. A staged copy is still
+//                  written but no longer marks the slot as holding the page.
+//
+//
+// Inputs       : REGION* region - region the page belongs to
+//              : int pageNum - pageNum of the page
+// Outputs      : None
+
+void swap_drop(REGION* region, int pageNum){
+    region->swapState[pageNum] = SWAP_NONE;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : find_staged_batch
+// Description  : Finds the batch, and the index in it, holding the staged copy
+//                  of a slot
+//
+//
+// Inputs       : SWAP* swap - swap instance
+//              : int slot - the slot to look for
+//              : int* index - set to the index of the slot in the batch
+// Outputs      : Returns the batch, null if the slot is not staged
+
+SWAP_BATCH* find_staged_batch(SWAP* swap, int slot, int* index){
+    SWAP_BATCH* batches[2] = {swap->staging, swap->writing};
+
+    for (int b = 0; b < 2; b++){
+        for (int i = 0; i < batches[b]->count; i++){
+            if (batches[b]->slots[i] == slot){
+                *index = i;
+                return batches[b];
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : submit_batch
+// Description  : Submits the staged batch's write-back. The pages are ordered by
+//                  slot and each run of sequential slots is written with one
+//                  request. The batch being written before is waited for first,
+//                  since its buffer becomes the next staging batch.
+//
+//
+// Inputs       : SWAP* swap - swap instance
+// Outputs      : None
+
+void submit_batch(SWAP* swap){
+    SWAP_BATCH* batch = swap->staging;
+    int order[SWAP_BATCH_PAGES];
+    int runs = 0;
+    int i;
+    int j;
+
+    if (batch->count == 0){
+        return;
+    }
+    wait_batch(swap, swap->writing);
+
+    // insertion sort of the staged pages by slot
+    for (i = 0; i < batch->count; i++){
+        for (j = i; (j > 0) && (batch->slots[order[j - 1]] > batch->slots[i]); j--){
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    for (i = 0; i < batch->count; i++){
+        batch->iov[i].iov_base = batch->buffer + (order[i] * swap->pageSize);
+        batch->iov[i].iov_len = swap->pageSize;
+        if ((i == 0) || (batch->slots[order[i]] != batch->slots[order[i - 1]] + 1)){
+            // start a new run of sequential slots
+            batch->io[runs].write = true;
+            batch->io[runs].iov = &batch->iov[i];
+            batch->io[runs].iovcnt = 0;
+            batch->io[runs].offset = (off_t)batch->slots[order[i]] * swap->pageSize;
+            batch->io[runs].batch = batch;
+            runs ++;
+        }
+        batch->io[runs - 1].iovcnt ++;
+    }
+
+    batch->pending = runs;
+    batch->failed = false;
+    for (i = 0; i < runs; i++){
+        submit_io(swap, &batch->io[i]);
+    }
+    flush_io(swap);
+
+    swap->staging = swap->writing;
+    swap->writing = batch;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : wait_batch
+// Description  : Waits until the write-back of a batch has completed, then marks
+//                  its pages as held by their slots and empties the batch
+//
+//
+// Inputs       : SWAP* swap - swap instance
+//              : SWAP_BATCH* batch - the batch being written
+// Outputs      : None
+
+void wait_batch(SWAP* swap, SWAP_BATCH* batch){
+    if (swap->useRing){
+        flush_io(swap);
+        while (batch->pending > 0){
+            reap_io(swap, true);
+        }
+    } else {
+        pthread_mutex_lock(&swap->lock);
+        while (batch->pending > 0){
+            pthread_cond_wait(&swap->workDone, &swap->lock);
+        }
+        pthread_mutex_unlock(&swap->lock);
+    }
+
+    if (batch->failed){
+        fprintf(stderr, "%s: swap write failed, contents of %d pages are lost\n", __func__, batch->count);
+    }
+    for (int i = 0; i < batch->count; i++){
+        // pages dropped or staged again since keep their newer state
+        if (*batch->states[i] == SWAP_STAGED){
+            *batch->states[i] = batch->failed ? SWAP_NONE : SWAP_VALID;
+        }
+    }
+    batch->count = 0;
+    batch->failed = false;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : submit_io
+// Description  : Queues an I/O request on the io_uring or the thread pool.
+//                  io_uring requests reach the kernel at the next flush_io.
+//
+//
+// Inputs       : SWAP* swap - swap instance
+//              : SWAP_IO* io - the I/O request
+// Outputs      : None
+
+void submit_io(SWAP* swap, SWAP_IO* io){
+    io->done = false;
+    io->next = NULL;
+
+    if (swap->useRing){
+        unsigned tail = *swap->sqTail;
+        unsigned index = tail & *swap->sqMask;
+        struct io_uring_sqe* sqe = &swap->sqes[index];
+
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = io->write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->fd = swap->fd;
+        sqe->addr = (uintptr_t)io->iov;
+        sqe->len = io->iovcnt;
+        sqe->off = io->offset;
+        sqe->user_data = (uintptr_t)io;
+        swap->sqArray[index] = index;
+        __atomic_store_n(swap->sqTail, tail + 1, __ATOMIC_RELEASE);
+        swap->toSubmit ++;
+    } else {
+        pthread_mutex_lock(&swap->lock);
+        if (swap->workTail == NULL){
+            swap->workHead = io;
+        } else {
+            swap->workTail->next = io;
+        }
+        swap->workTail = io;
+        pthread_cond_signal(&swap->workReady);
+        pthread_mutex_unlock(&swap->lock);
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : flush_io
+// Description  : Hands the queued io_uring requests to the kernel. A full
+//                  completion queue is drained before retrying. If the kernel
+//                  refuses the requests for any other reason, or takes none of
+//                  them, they are failed, since this runs in the fault handler
+//                  and cannot keep retrying.
+//
+//
+// Inputs       : SWAP* swap - swap instance
+// Outputs      : None
+
+void flush_io(SWAP* swap){
+    int submitted;
+    unsigned head;
+    struct io_uring_sqe* sqe;
+
+    while (swap->useRing && (swap->toSubmit > 0)){
+        submitted = syscall(__NR_io_uring_enter, swap->ringFd, swap->toSubmit, 0, 0, NULL, 0);
+        if (submitted > 0){
+            swap->toSubmit -= submitted;
+        } else if ((submitted < 0) && ((errno == EAGAIN) || (errno == EBUSY))){
+            // completions are backed up, collect them to make room
+            reap_io(swap, false);
+        } else if ((submitted == 0) || (errno != EINTR)){
+            // fail the requests the kernel did not take and take them off the ring
+            int error = (submitted == 0) ? EIO : errno;
+            head = __atomic_load_n(swap->sqHead, __ATOMIC_ACQUIRE);
+            for (unsigned entry = head; entry != *swap->sqTail; entry ++){
+                sqe = &swap->sqes[swap->sqArray[entry & *swap->sqMask]];
+                complete_io(swap, (SWAP_IO*)(uintptr_t)sqe->user_data, -error);
+            }
+            __atomic_store_n(swap->sqTail, head, __ATOMIC_RELEASE);
+            swap->toSubmit = 0;
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : wait_io
+// Description  : Waits until an I/O request has completed
+//
+//
+// Inputs       : SWAP* swap - swap instance
+//              : SWAP_IO* io - the I/O request
+// Outputs      : None
+
+void wait_io(SWAP* swap, SWAP_IO* io){
+    if (swap->useRing){
+        flush_io(swap);
+        while (!io->done){
+            reap_io(swap, true);
+        }
+    } else {
+        pthread_mutex_lock(&swap->lock);
+        while (!io->done){
+            pthread_cond_wait(&swap->workDone, &swap->lock);
+        }
+        pthread_mutex_unlock(&swap->lock);
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : reap_io
+// Description  : Collects completed io_uring requests, waiting for one if asked
+//
+//
+// Inputs       : SWAP* swap - swap instance
+//              : bool wait - whether to wait for a completion
+// Outputs      : None
+
+void reap_io(SWAP* swap, bool wait){
+    unsigned head;
+    struct io_uring_cqe* cqe;
+
+    if (wait){
+        syscall(__NR_io_uring_enter, swap->ringFd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    }
+
+    head = *swap->cqHead;
+    while (head != __atomic_load_n(swap->cqTail, __ATOMIC_ACQUIRE)){
+        cqe = &swap->cqes[head & *swap->cqMask];
+        complete_io(swap, (SWAP_IO*)(uintptr_t)cqe->user_data, cqe->res);
+        head ++;
+    }
+    __atomic_store_n(swap->cqHead, head, __ATOMIC_RELEASE);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : complete_io
+// Description  : Marks an I/O request as completed and counts it off its batch.
+//                  Called with the lock held when the thread pool is used.
+//
+//
+// Inputs       : SWAP* swap - swap instance
+//              : SWAP_IO* io - the completed I/O request
+//              : ssize_t result - bytes transferred, negative on failure
+// Outputs      : None
+
+void complete_io(SWAP* swap, SWAP_IO* io, ssize_t result){
+    io->result = result;
+    io->done = true;
+
+    if (io->batch != NULL){
+        if (result != (ssize_t)io->iovcnt * swap->pageSize){
+            io->batch->failed = true;
+        }
+        io->batch->pending --;
+    }
+}
@@ -0,0 +1,140 @@
+#ifndef SWAP_H
+#define SWAP_H
+
+#include <pthread.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include "vmm.h"
+
+// Swap pipeline moving evicted pages to a swap file and back
+
+typedef struct swap_struct SWAP;
+typedef struct swap_batch_struct SWAP_BATCH;
+typedef struct swap_io_struct SWAP_IO;
+
+// Virtual pages whose swap slots are allocated together as one contiguous group
+#define SWAP_CLUSTER_PAGES 8
+// Dirty victims staged before their write-back is submitted
+#define SWAP_BATCH_PAGES 8
+// Entries in the io_uring submission queue, enough for two batches and a page-in
+#define SWAP_RING_ENTRIES 32
+// Threads doing pread/pwrite when io_uring is not available
+#define SWAP_THREADS 2
+
+enum swap_state
+{
+    SWAP_NONE = 0,   // Page has no copy in swap, its memory holds the contents
+    SWAP_STAGED = 1, // Page contents are staged in a write-back batch
+    SWAP_VALID = 2,  // Page contents are in its swap slot
+};
+
+
+struct swap_io_struct
+{
+    bool write;
+    struct iovec* iov;
+    int iovcnt;
+    off_t offset;
+    SWAP_BATCH* batch;
+    bool done;
+    ssize_t result;
+    SWAP_IO* next;
+};
+
+
+struct swap_batch_struct
+{
+    char* buffer;
+    int slots[SWAP_BATCH_PAGES];
+    int* states[SWAP_BATCH_PAGES];
+    int count;
+    int pending;
+    bool failed;
+    struct iovec iov[SWAP_BATCH_PAGES];
+    SWAP_IO io[SWAP_BATCH_PAGES];
+};
+
+
+struct swap_struct
+{
+    int fd;
+    int pageSize;
+    int nextSlot;
+    SWAP_BATCH batches[2];
+    SWAP_BATCH* staging;
+    SWAP_BATCH* writing;
+
+    // io_uring
+    bool useRing;
+    int ringFd;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    struct io_uring_sqe* sqes;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    struct io_uring_cqe* cqes;
+    int toSubmit;
+
+    // thread pool fallback
+    pthread_t threads[SWAP_THREADS];
+    int numThreads;
+    pthread_mutex_t lock;
+    pthread_cond_t workReady;
+    pthread_cond_t workDone;
+    SWAP_IO* workHead;
+    SWAP_IO* workTail;
+};
+
+
+SWAP* init_swap(int pageSize);
+    // Initializes the swap file and the io_uring, or the thread pool if io_uring is not available
+
+void destroy_swap(SWAP* swap);
+    // Releases a swap whose setup failed
+
+bool init_ring(SWAP* swap);
+    // Sets up the io_uring used to submit swap I/O
+
+void* swap_worker(void* arg);
+    // Thread pool worker doing the queued swap I/O with pread/pwrite
+
+int swap_slot(SWAP* swap, REGION* region, int pageNum);
+    // Returns the swap slot of a page, allocating its cluster of slots if needed
+
+void swap_out(SWAP* swap, REGION* region, PAGE* page);
+    // Stages an evicted dirty page for write-back and releases the page's memory
+
+void swap_in(SWAP* swap, REGION* region, int pageNum);
+    // Brings the contents of a page back from swap, leaving the page read/write
+
+void swap_drop(REGION* region, int pageNum);
+    // Forgets the swapped contents of a page
+
+SWAP_BATCH* find_staged_batch(SWAP* swap, int slot, int* index);
+    // Finds the batch, and the index in it, holding the staged copy of a slot
+
+void submit_batch(SWAP* swap);
+    // Submits the staged batch's write-back as one write per run of sequential slots
+
+void wait_batch(SWAP* swap, SWAP_BATCH* batch);
+    // Waits until the write-back of a batch has completed
+
+void submit_io(SWAP* swap, SWAP_IO* io);
+    // Queues an I/O request on the io_uring or the thread pool
+
+void flush_io(SWAP* swap);
+    // Hands the queued io_uring requests to the kernel
+
+void wait_io(SWAP* swap, SWAP_IO* io);
+    // Waits until an I/O request has completed
+
+void reap_io(SWAP* swap, bool wait);
+    // Collects completed io_uring requests, waiting for one if asked
+
+void complete_io(SWAP* swap, SWAP_IO* io, ssize_t result);
+    // Marks an I/O request as completed and finishes its batch if it was the last one
+
+#endif
@@ -0,0 +1,220 @@
+#include "test_driver.h"
+
+// Access hint driver test, every case runs with TEST_FRAMES frames over TEST_PAGES pages
+
+#define TEST_PAGES 8
+#define TEST_FRAMES 4
+
+int testPageSize;
+char *vm;
+bool evicted[TEST_PAGES];
+
+// Record which pages are evicted
+void mm_logger(int virt_page, int fault_type, int evicted_page, int write_back, unsigned int phy_addr)
+{
+    if (evicted_page >= 0)
+    {
+        evicted[evicted_page] = true;
+    }
+}
+
+void init_case(int policy, int numFrames)
+{
+    CHECK(posix_memalign((void **)&vm, testPageSize, TEST_PAGES * testPageSize) == 0, "posix_memalign failed");
+    memset(vm, 0, TEST_PAGES * testPageSize);
+    mm_init(policy, vm, TEST_PAGES * testPageSize, numFrames, testPageSize);
+}
+
+// Fills a page with a value
+void write_page(int page, char value)
+{
+    memset(vm + page * testPageSize, value, testPageSize);
+}
+
+// Checks that a page is filled with a value
+void check_page(int page, char value)
+{
+    for (int offset = 0; offset < testPageSize; offset++)
+    {
+        CHECK(vm[page * testPageSize + offset] == value, "page %d offset %d reads %d, expected %d", page, offset,
+              vm[page * testPageSize + offset], value);
+    }
+}
+
+// Returns whether a page of managed memory is backed by physical memory
+bool page_resident(int page)
+{
+    unsigned char resident;
+    CHECK(mincore(vm + page * testPageSize, testPageSize, &resident) == 0, "mincore failed");
+    return resident & 1;
+}
+
+// Returns the page-ins of the region
+int region_faults()
+{
+    int faults, writeBacks, frames;
+    mm_region_stats(vm, &faults, &writeBacks, &frames);
+    return faults;
+}
+
+// Returns the frames held by the region
+int region_frames()
+{
+    int faults, writeBacks, frames;
+    mm_region_stats(vm, &faults, &writeBacks, &frames);
+    return frames;
+}
+
+// Bad ranges and hints are rejected
+void test_arguments(int policy, int numFrames)
+{
+    init_case(policy, numFrames);
+    CHECK(mm_advise(vm, vm, 0, MM_ADV_HOT) == -1, "empty range accepted");
+    CHECK(mm_advise(vm, vm - testPageSize, testPageSize, MM_ADV_HOT) == -1, "range below the region accepted");
+    CHECK(mm_advise(vm, vm, (TEST_PAGES + 1) * testPageSize, MM_ADV_HOT) == -1, "range past the region accepted");
+    CHECK(mm_advise(vm + testPageSize, vm + testPageSize, testPageSize, MM_ADV_HOT) == -1, "region's inner address accepted");
+    CHECK(mm_advise(vm, vm, testPageSize, MM_ADV_HOT + 1) == -1, "unknown hint accepted");
+    CHECK(mm_advise(vm, vm + 1, 1, MM_ADV_HOT) == 0, "range inside a page rejected");
+}
+
+// DONTNEED frees the frames of resident pages, releases the memory of every page and reads back zero
+// for resident and swapped pages alike
+void test_dontneed(int policy, int numFrames)
+{
+    init_case(policy, numFrames);
+    for (int page = 0; page < TEST_PAGES; page++)
+    {
+        write_page(page, page + 1);
+    }
+    CHECK(region_frames() == numFrames, "region holds %d frames", region_frames());
+
+    // Pages 2 to 5 hold both resident and swapped pages
+    CHECK(mm_advise(vm, vm + 2 * testPageSize + 1, 4 * testPageSize - 2, MM_ADV_DONTNEED) == 0, "DONTNEED rejected");
+    CHECK(region_frames() < numFrames, "DONTNEED freed no frame");
+    for (int page = 2; page <= 5; page++)
+    {
+        CHECK(!page_resident(page), "page %d still in memory after DONTNEED", page);
+    }
+    for (int page = 0; page < TEST_PAGES; page++)
+    {
+        check_page(page, ((page >= 2) && (page <= 5)) ? 0 : page + 1);
+    }
+}
+
+// WILLNEED only prefaults into free frames, never evicting a resident page for a speculative one
+void test_willneed(int policy, int numFrames)
+{
+    int faults;
+
+    init_case(policy, numFrames);
+    for (int page = 0; page < numFrames; page++)
+    {
+        write_page(page, page + 1);
+    }
+
+    // Every frame is in use, so nothing is prefaulted
+    CHECK(mm_advise(vm, vm + numFrames * testPageSize, numFrames * testPageSize, MM_ADV_WILLNEED) == 0,
+          "WILLNEED rejected");
+    faults = region_faults();
+    for (int page = 0; page < numFrames; page++)
+    {
+        check_page(page, page + 1);
+    }
+    CHECK(region_faults() == faults, "WILLNEED evicted a resident page");
+
+    // With one frame freed, only the first page of the range is prefaulted
+    mm_advise(vm, vm, testPageSize, MM_ADV_DONTNEED);
+    mm_advise(vm, vm + numFrames * testPageSize, numFrames * testPageSize, MM_ADV_WILLNEED);
+    CHECK(region_frames() == numFrames, "region holds %d frames", region_frames());
+    faults = region_faults();
+    check_page(numFrames, 0);
+    CHECK(region_faults() == faults, "WILLNEED did not prefault page %d", numFrames);
+    check_page(numFrames + 1, 0);
+    CHECK(region_faults() == faults + 1, "WILLNEED prefaulted past the free frames");
+
+    // Prefaulted pages come back with their swapped contents
+    for (int page = 0; page < TEST_PAGES; page++)
+    {
+        write_page(page, page + 1);
+    }
+    mm_advise(vm, vm, TEST_PAGES * testPageSize, MM_ADV_DONTNEED);
+    for (int page = 0; page < TEST_PAGES; page++)
+    {
+        write_page(page, page + 1);
+    }
+    mm_advise(vm, vm + (TEST_PAGES - numFrames) * testPageSize, numFrames * testPageSize, MM_ADV_DONTNEED);
+    mm_advise(vm, vm, TEST_PAGES * testPageSize, MM_ADV_WILLNEED);
+    CHECK(region_frames() == numFrames, "region holds %d frames", region_frames());
+    faults = region_faults();
+    for (int page = 0; page < TEST_PAGES - numFrames; page++)
+    {
+        check_page(page, page + 1);
+    }
+    CHECK(region_faults() == faults, "WILLNEED did not prefault the swapped pages");
+}
+
+// A HOT page is kept resident while other pages are evicted around it
+void test_hot(int policy, int numFrames)
+{
+    init_case(policy, numFrames);
+    mm_advise(vm, vm, testPageSize, MM_ADV_HOT);
+    for (int round = 0; round < 4; round++)
+    {
+        for (int page = 0; page < TEST_PAGES; page++)
+        {
+            write_page(page, round + page);
+        }
+    }
+    CHECK(!evicted[0], "HOT page was evicted");
+
+    // With every page hot, pages are still evicted
+    mm_advise(vm, vm, TEST_PAGES * testPageSize, MM_ADV_HOT);
+    for (int page = 0; page < TEST_PAGES; page++)
+    {
+        check_page(page, 3 + page);
+    }
+
+    // NORMAL clears the hint
+    memset(evicted, 0, sizeof(evicted));
+    mm_advise(vm, vm, TEST_PAGES * testPageSize, MM_ADV_NORMAL);
+    for (int page = 0; page < TEST_PAGES; page++)
+    {
+        check_page(page, 3 + page);
+    }
+    CHECK(evicted[0], "page 0 kept resident after NORMAL");
+}
+
+// Pages a SEQUENTIAL scan has passed are evicted before older pages outside the scan
+void test_sequential(int policy, int numFrames)
+{
+    init_case(policy, numFrames);
+    write_page(0, 1);
+    write_page(1, 2);
+    mm_advise(vm, vm + 2 * testPageSize, (TEST_PAGES - 2) * testPageSize, MM_ADV_SEQUENTIAL);
+    for (int page = 2; page < TEST_PAGES; page++)
+    {
+        write_page(page, page + 1);
+    }
+    CHECK(!evicted[0] && !evicted[1], "page outside the scan was evicted before the scanned pages");
+    for (int page = 0; page < TEST_PAGES; page++)
+    {
+        check_page(page, page + 1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool passed = true;
+
+    testPageSize = sysconf(_SC_PAGE_SIZE);
+    for (int policy = MM_FIFO; policy <= MM_THIRD; policy++)
+    {
+        passed &= run_case(test_arguments, policy, TEST_FRAMES, "advise arguments  Policy=%d", policy);
+        passed &= run_case(test_dontneed, policy, TEST_FRAMES, "advise DONTNEED  Policy=%d", policy);
+        passed &= run_case(test_willneed, policy, TEST_FRAMES, "advise WILLNEED  Policy=%d", policy);
+        passed &= run_case(test_hot, policy, TEST_FRAMES, "advise HOT  Policy=%d", policy);
+        passed &= run_case(test_sequential, policy, TEST_FRAMES, "advise SEQUENTIAL  Policy=%d", policy);
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
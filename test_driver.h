@@ -0,0 +1,57 @@
+#ifndef TEST_DRIVER_H
+#define TEST_DRIVER_H
+
+#include <stdarg.h>
+#include <sys/wait.h>
+
+#include "interface.h"
+
+// Shared harness of the driver tests
+// Build and run them with: make test (runAllTests.sh runs it too)
+// Every case runs in its own process, since the manager can only be initialized once.
+// Each driver defines its own mm_logger and the page size it reads from testPageSize.
+
+extern int testPageSize;
+
+// Fails the running case with a message
+#define CHECK(cond, ...)                  \
+    do                                    \
+    {                                     \
+        if (!(cond))                      \
+        {                                 \
+            fprintf(stderr, __VA_ARGS__); \
+            fprintf(stderr, "\n");        \
+            exit(EXIT_FAILURE);           \
+        }                                 \
+    } while (0)
+
+// Runs test(first, second) in a child process and waits for it, returns whether it passed.
+// The case is named by a printf format and its arguments.
+static bool run_case(void (*test)(int, int), int first, int second, const char *format, ...)
+{
+    char name[128];
+    va_list args;
+    int status;
+
+    va_start(args, format);
+    vsnprintf(name, sizeof(name), format, args);
+    va_end(args);
+
+    printf("Testing:  %s\n", name);
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        test(first, second);
+        exit(EXIT_SUCCESS);
+    }
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS))
+    {
+        fprintf(stderr, "FAILED: %s\n", name);
+        return false;
+    }
+    return true;
+}
+
+#endif
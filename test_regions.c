@@ -0,0 +1,189 @@
+#include "test_driver.h"
+
+// Region and replacement scope driver test
+
+#define TEST_PAGES 8
+#define TEST_OPS 20000
+#define TEST_RANDOM_REGIONS 4
+
+int testPageSize;
+long faultCounter;
+
+// Count the faults instead of recording them
+void mm_logger(int virt_page, int fault_type, int evicted_page, int write_back, unsigned int phy_addr)
+{
+    faultCounter++;
+}
+
+char *alloc_region(int numPages)
+{
+    void *vm;
+    CHECK(posix_memalign(&vm, testPageSize, numPages * testPageSize) == 0, "posix_memalign failed");
+    memset(vm, 0, numPages * testPageSize);
+    return (char *)vm;
+}
+
+// Writes a value into every page of a region
+void write_pages(char *vm, int numPages, char value)
+{
+    for (int page = 0; page < numPages; page++)
+    {
+        vm[page * testPageSize + page] = value + page;
+    }
+}
+
+// Checks the values written by write_pages
+void check_pages(char *vm, int numPages, char value)
+{
+    for (int page = 0; page < numPages; page++)
+    {
+        CHECK(vm[page * testPageSize + page] == (char)(value + page), "page %d of %p reads %d, expected %d",
+              page, vm, vm[page * testPageSize + page], (char)(value + page));
+    }
+}
+
+// mm_add_region rejects bad regions, and a region always gets a frame even if its quota is the floor
+void test_add_region(int policy, int scope)
+{
+    int faults, writeBacks, frames;
+    char *first = alloc_region(TEST_PAGES);
+    char *second = alloc_region(TEST_PAGES);
+    char *third = alloc_region(TEST_PAGES);
+
+    mm_init(policy, first, TEST_PAGES * testPageSize, 2, testPageSize);
+    mm_set_scope(scope);
+    CHECK(mm_add_region(first + testPageSize, testPageSize, 0, 1) == -1, "overlapping region accepted");
+    CHECK(mm_add_region(second + 1, testPageSize, 0, 1) == -1, "misaligned region accepted");
+    CHECK(mm_add_region(second, TEST_PAGES * testPageSize, 3, 1) == -1, "min guarantee over the frames accepted");
+    CHECK(mm_add_region(second, TEST_PAGES * testPageSize, 0, 0) == -1, "zero weight accepted");
+    CHECK(mm_add_region(second, TEST_PAGES * testPageSize, 0, 1) == 0, "valid region rejected");
+    CHECK(mm_add_region(third, TEST_PAGES * testPageSize, 0, 1) == -1, "more regions than frames accepted");
+    CHECK(mm_region_stats(third, &faults, &writeBacks, &frames) == -1, "stats of an unmanaged region");
+    CHECK(mm_region_stats(second + testPageSize, &faults, &writeBacks, &frames) == -1, "stats of a region's inner address");
+
+    // The second region's first touch happens with every frame held by the first
+    write_pages(first, TEST_PAGES, 1);
+    write_pages(second, TEST_PAGES, 2);
+    check_pages(first, TEST_PAGES, 1);
+    check_pages(second, TEST_PAGES, 2);
+
+    CHECK(mm_region_stats(second, &faults, &writeBacks, &frames) == 0, "stats of a managed region failed");
+    CHECK(frames >= 1, "region holds %d frames", frames);
+    CHECK(faults >= 2 * TEST_PAGES, "region counted %d faults", faults);
+}
+
+// Local scope keeps each region to its quota, global scope lets one region take every free frame
+void test_scope(int policy, int scope)
+{
+    int firstFaults, firstWriteBacks, firstFrames;
+    int secondFaults, secondWriteBacks, secondFrames;
+    char *first = alloc_region(TEST_PAGES);
+    char *second = alloc_region(TEST_PAGES);
+
+    mm_init(policy, first, TEST_PAGES * testPageSize, 4, testPageSize);
+    mm_set_scope(scope);
+    CHECK(mm_add_region(second, TEST_PAGES * testPageSize, 1, 1) == 0, "valid region rejected");
+
+    // An unknown scope is ignored, so the checks below still see the scope set above
+    int savedStderr = dup(STDERR_FILENO);
+    freopen("/dev/null", "w", stderr);
+    mm_set_scope(MM_LOCAL + 1);
+    mm_set_scope(0);
+    fflush(stderr);
+    dup2(savedStderr, STDERR_FILENO);
+    close(savedStderr);
+
+    // Quotas are 2 and 2
+    write_pages(first, TEST_PAGES, 1);
+    mm_region_stats(first, &firstFaults, &firstWriteBacks, &firstFrames);
+    CHECK(firstFrames == ((scope == MM_LOCAL) ? 2 : 4), "first region holds %d frames", firstFrames);
+    CHECK(firstFaults == TEST_PAGES, "first region counted %d faults", firstFaults);
+
+    write_pages(second, TEST_PAGES, 2);
+    check_pages(first, TEST_PAGES, 1);
+    check_pages(second, TEST_PAGES, 2);
+    mm_region_stats(first, &firstFaults, &firstWriteBacks, &firstFrames);
+    mm_region_stats(second, &secondFaults, &secondWriteBacks, &secondFrames);
+    CHECK(firstFrames + secondFrames == 4, "regions hold %d and %d of 4 frames", firstFrames, secondFrames);
+    CHECK(secondFrames >= 1, "second region holds %d frames under its min guarantee", secondFrames);
+    if (scope == MM_LOCAL)
+    {
+        CHECK((firstFrames == 2) && (secondFrames == 2), "regions hold %d and %d frames over their quotas",
+              firstFrames, secondFrames);
+    }
+    CHECK(firstWriteBacks + secondWriteBacks > 0, "no write-backs counted");
+    CHECK(firstFaults + secondFaults <= faultCounter, "regions counted more faults than were logged");
+}
+
+// Random reads and writes over several regions, checked against a copy
+void test_random(int policy, int scope)
+{
+    char *regions[TEST_RANDOM_REGIONS];
+    char shadow[TEST_RANDOM_REGIONS][TEST_PAGES] = {{0}};
+    int totalFrames = 0;
+
+    srand(policy * 10 + scope);
+    regions[0] = alloc_region(TEST_PAGES);
+    mm_init(policy, regions[0], TEST_PAGES * testPageSize, TEST_RANDOM_REGIONS, testPageSize);
+    mm_set_scope(scope);
+    for (int i = 1; i < TEST_RANDOM_REGIONS; i++)
+    {
+        regions[i] = alloc_region(TEST_PAGES);
+        CHECK(mm_add_region(regions[i], TEST_PAGES * testPageSize, rand() % 2, 1 + rand() % 3) == 0, "valid region rejected");
+    }
+
+    for (int op = 0; op < TEST_OPS; op++)
+    {
+        int region = rand() % TEST_RANDOM_REGIONS;
+        int page = rand() % TEST_PAGES;
+        char *addr = regions[region] + page * testPageSize;
+        if (rand() % 2)
+        {
+            *addr = shadow[region][page] = rand();
+        }
+        else
+        {
+            CHECK(*addr == shadow[region][page], "region %d page %d reads %d, expected %d", region, page, *addr,
+                  shadow[region][page]);
+        }
+        // Switching the scope on the fly keeps working
+        if (op == TEST_OPS / 2)
+        {
+            mm_set_scope((scope == MM_LOCAL) ? MM_GLOBAL : MM_LOCAL);
+        }
+    }
+
+    for (int i = 0; i < TEST_RANDOM_REGIONS; i++)
+    {
+        int faults, writeBacks, frames;
+        CHECK(mm_region_stats(regions[i], &faults, &writeBacks, &frames) == 0, "stats of a managed region failed");
+        totalFrames += frames;
+    }
+    CHECK(totalFrames <= TEST_RANDOM_REGIONS, "regions hold %d of %d frames", totalFrames, TEST_RANDOM_REGIONS);
+}
+
+const char *scope_name(int scope)
+{
+    return (scope == MM_LOCAL) ? "local" : "global";
+}
+
+int main(int argc, char *argv[])
+{
+    bool passed = true;
+
+    testPageSize = sysconf(_SC_PAGE_SIZE);
+    for (int policy = MM_FIFO; policy <= MM_THIRD; policy++)
+    {
+        for (int scope = MM_GLOBAL; scope <= MM_LOCAL; scope++)
+        {
+            passed &= run_case(test_add_region, policy, scope, "add_region  Policy=%d  Scope=%s", policy,
+                               scope_name(scope));
+            passed &= run_case(test_scope, policy, scope, "scope  Policy=%d  Scope=%s", policy,
+                               scope_name(scope));
+            passed &= run_case(test_random, policy, scope, "random  Policy=%d  Scope=%s", policy,
+                               scope_name(scope));
+        }
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
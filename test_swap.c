@@ -0,0 +1,102 @@
+#include "test_driver.h"
+
+// Swap driver test, checks that evicted pages come back with their contents
+// test_swap uses io_uring, test_swap_pool is built with -DSWAP_NO_URING to use the thread pool.
+
+#define TEST_PAGES 40
+#define TEST_MAX_FRAMES 16
+#define TEST_OPS 5000
+
+#ifdef SWAP_NO_URING
+#define TEST_BACKEND "thread pool"
+#else
+#define TEST_BACKEND "io_uring"
+#endif
+
+int testPageSize;
+
+// The faults are checked through mm_region_stats
+void mm_logger(int virt_page, int fault_type, int evicted_page, int write_back, unsigned int phy_addr)
+{
+}
+
+// Checks a page of managed memory against its copy
+void check_page(char *vm, char *shadow, int page)
+{
+    char *addr = vm + page * testPageSize;
+    char *expected = shadow + page * testPageSize;
+
+    for (int offset = 0; offset < testPageSize; offset++)
+    {
+        CHECK(addr[offset] == expected[offset], "page %d offset %d reads %d, expected %d", page, offset, addr[offset],
+              expected[offset]);
+    }
+}
+
+// Fills whole pages, reads them back in order and then runs random reads and writes.
+// With fewer frames than pages every pass evicts dirty pages, so pages are read back from
+// the staging batch, from the batch being written and from their swap slots.
+void test_swap(int policy, int numFrames)
+{
+    void *vm;
+    int faults, writeBacks, frames;
+    char *shadow = calloc(TEST_PAGES, testPageSize);
+
+    CHECK(posix_memalign(&vm, testPageSize, TEST_PAGES * testPageSize) == 0, "posix_memalign failed");
+    memset(vm, 0, TEST_PAGES * testPageSize);
+    mm_init(policy, vm, TEST_PAGES * testPageSize, numFrames, testPageSize);
+    srand(policy * 100 + numFrames);
+
+    for (int pass = 1; pass <= 3; pass++)
+    {
+        for (int page = 0; page < TEST_PAGES; page++)
+        {
+            memset(shadow + page * testPageSize, pass * TEST_PAGES + page, testPageSize);
+            memcpy((char *)vm + page * testPageSize, shadow + page * testPageSize, testPageSize);
+        }
+        for (int page = 0; page < TEST_PAGES; page++)
+        {
+            check_page(vm, shadow, page);
+        }
+    }
+
+    for (int op = 0; op < TEST_OPS; op++)
+    {
+        int page = rand() % TEST_PAGES;
+        if (rand() % 2)
+        {
+            int offset = rand() % testPageSize;
+            ((char *)vm)[page * testPageSize + offset] = shadow[page * testPageSize + offset] = rand();
+        }
+        else
+        {
+            check_page(vm, shadow, page);
+        }
+    }
+
+    for (int page = 0; page < TEST_PAGES; page++)
+    {
+        check_page(vm, shadow, page);
+    }
+
+    CHECK(mm_region_stats(vm, &faults, &writeBacks, &frames) == 0, "stats of a managed region failed");
+    CHECK(frames == numFrames, "region holds %d of %d frames", frames, numFrames);
+    CHECK(writeBacks > 0, "no write-backs counted");
+}
+
+int main(int argc, char *argv[])
+{
+    bool passed = true;
+
+    testPageSize = sysconf(_SC_PAGE_SIZE);
+    for (int policy = MM_FIFO; policy <= MM_THIRD; policy++)
+    {
+        for (int numFrames = 1; numFrames <= TEST_MAX_FRAMES; numFrames++)
+        {
+            passed &= run_case(test_swap, policy, numFrames, "swap  Backend=%s  Policy=%d  NumFrames=%d", TEST_BACKEND,
+                               policy, numFrames);
+        }
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
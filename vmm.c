@@ -1,4 +1,5 @@
 #include "vmm.h"
+#include "swap.h"
 
 // Memory Manager implementation
 // Implement all other functions here...
@@ -18,8 +19,13 @@ QUEUE* init_queue(){
     if(queue) {
         queue->head = NULL;
         queue->tail = NULL;
-        queue->hand = NULL;
         queue->size = 0;
+        queue->sequentialPages = 0;
+        queue->hotPages = 0;
+#ifdef WITH_THIRD_CHANCE
+        queue->hand = NULL;
+        queue->circular = false;
+#endif
         return queue;
     } else {
         return NULL;
@@ -40,12 +46,15 @@ PAGE* init_page(int pageNum){
     PAGE* newPage = malloc(sizeof(PAGE));
 
     newPage->pageNum = pageNum;
-    newPage->referenced = 0; // Set depending on fault type later
     newPage->modified = 0;   // Set depending on fault type later
     newPage->frameNum = -1;  // Set when inserted into queue
+#ifdef WITH_THIRD_CHANCE
+    newPage->referenced = 0; // Set depending on fault type later
     newPage->canRead = false;
     newPage->canWrite = false;
     newPage->thirdChanceTaken = false;
+#endif
+    newPage->advice = MM_ADV_NORMAL; // Set from the page's access hint later
     newPage->next = NULL;
 
     return newPage;
@@ -55,12 +64,13 @@ PAGE* init_page(int pageNum){
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Function     : queue_insert
-// Description  : Inserts a given page into the queue, evicting a page if needed
+// Description  : Inserts a given page into the queue, evicting a page if needed.
+//                  A page that fits without evicting must already hold its frame.
 //                  
 //
 // Inputs       : QUEUE* queue - queue instance to insert the page into
 //              : PAGE* newPage - page instance to be inserted into the queue
-//              : int numFrames - number of frames in the queue
+//              : int numFrames - number of frames the queue may hold
 //              : void* vm_ptr - pointer to the start of virtual memory
 //              : int pageSize - the size of memory for each page
 //              : int policy - the virtual memory manager's policy, either FIFO or THIRD
@@ -71,58 +81,213 @@ PAGE* queue_insert(QUEUE* queue, PAGE* newPage, int numFrames, void* vm_ptr, int
     
     if(queue->size == 0) {
         // if queue empty, set the page as the queue's head
-        newPage->frameNum = 0;
         queue->head = newPage;
         queue->tail = newPage;
-        if (policy == MM_THIRD){
+#ifdef WITH_THIRD_CHANCE
+        if (IS_THIRD(policy)){
             queue->hand = newPage;
         }
+#endif
         queue->size ++;
     }
     else if(queue->size < numFrames) {
         // if queue is not yet full, add the page to the end of the queue
-        newPage->frameNum = queue->size;
+#ifdef WITH_THIRD_CHANCE
+        if (IS_THIRD(policy) && queue->circular){
+            // the queue was allowed more frames after it filled up
+            open_queue(queue);
+        }
+#endif
         queue->tail->next = newPage;
         queue->tail = newPage;
         queue->size ++;
-        if ((queue->size == numFrames) && (policy == MM_THIRD)){
+#ifdef WITH_THIRD_CHANCE
+        if ((queue->size == numFrames) && IS_THIRD(policy)){
             // if the new page added fills the queue, for a third chance policy the last page
             // must point to the head, making it a circular queue
             newPage->next = queue->head;
+            queue->circular = true;
         }
+#endif
     }
     else if(queue->size == numFrames){
-        if (policy == MM_FIFO){
-            // if the queue is full, evict the head and add the page to the tail
-            evictedPage = queue->head;
-            queue->head = queue->head->next;
+        // pages advised as sequential that the scan has already passed are evicted first
+        if ((numFrames > 1) && (queue->sequentialPages > 0)){
+            evictedPage = find_sequential_page(queue, newPage->pageNum, policy);
+        }
+
+        if ((evictedPage == NULL) && IS_FIFO(policy)){
+            // if the queue is full, evict the oldest page that is not advised as hot
+            evictedPage = find_fifo_page(queue);
+        }
+
+        if (IS_FIFO(policy)){
+            // remove the evicted page and add the new page to the tail in its frame
+            queue_remove(queue, evictedPage, policy);
             newPage->frameNum = evictedPage->frameNum;
-            queue->tail->next = newPage;
-            queue->tail = newPage;
-            // Needed in the case of single available frame
-            if(queue->head == NULL) {
+            if (queue->size == 0){
+                // Needed in the case of single available frame
                 queue->head = newPage;
+            } else {
+                queue->tail->next = newPage;
+            }
+            queue->tail = newPage;
+            queue->size ++;
+        }
+#ifdef WITH_THIRD_CHANCE
+        else if (IS_THIRD(policy) && (numFrames > 1)){
+            if (!queue->circular){
+                // the queue was held to fewer frames, so it is full without being closed yet
+                queue->tail->next = queue->head;
+                queue->circular = true;
             }
-        } else if ((policy == MM_THIRD) && (numFrames > 1)){
             // for third chance policy, find the page needed to be evicted and replace it
-            evictedPage = find_eviction_page(queue, vm_ptr, pageSize);
+            if (evictedPage == NULL){
+                evictedPage = find_eviction_page(queue, vm_ptr, pageSize);
+                queue->hand = evictedPage;
+            }
             PAGE* previousPage = find_previous_page(evictedPage);
+            count_advice(queue, evictedPage->advice, -1);
             newPage->frameNum = evictedPage->frameNum;
             newPage->next = evictedPage->next;
             previousPage->next = newPage;
-            queue->hand = newPage->next;
-        } else if ((policy == MM_THIRD) && (numFrames == 1)){
+            if (queue->hand == evictedPage){
+                queue->hand = newPage->next;
+            }
+        } else if (IS_THIRD(policy) && (numFrames == 1)){
             // if the queue is only of size one, just replace the existing page
             evictedPage = queue->hand;
+            count_advice(queue, evictedPage->advice, -1);
             newPage->frameNum = evictedPage->frameNum;
+            queue->head = newPage;
+            queue->tail = newPage;
             queue->hand = newPage;
+            queue->circular = false;
         }
+#endif
     } 
+    count_advice(queue, newPage->advice, 1);
     
     return evictedPage;
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : queue_remove
+// Description  : Removes a given page from the queue. A circular third chance
+//                  queue is first opened up behind the hand, so later inserts
+//                  land just behind the hand again. The page keeps its frameNum
+//                  for the caller to reuse or release.
+//                  
+//
+// Inputs       : QUEUE* queue - queue instance to remove the page from
+//              : PAGE* page - page instance to be removed
+//              : int policy - the virtual memory manager's policy, either FIFO or THIRD
+// Outputs      : Returns the removed page
+
+PAGE* queue_remove(QUEUE* queue, PAGE* page, int policy){
+    PAGE* previousPage;
+
+    if (queue->size == 1){
+        // removing the only page leaves an empty queue
+        queue->head = NULL;
+        queue->tail = NULL;
+#ifdef WITH_THIRD_CHANCE
+        queue->hand = NULL;
+        queue->circular = false;
+#endif
+    } else {
+#ifdef WITH_THIRD_CHANCE
+        if (IS_THIRD(policy) && queue->circular){
+            open_queue(queue);
+        }
+#endif
+
+        if (page == queue->head){
+            queue->head = page->next;
+        } else {
+            previousPage = queue->head;
+            while (previousPage->next != page){
+                previousPage = previousPage->next;
+            }
+            previousPage->next = page->next;
+            if (page == queue->tail){
+                queue->tail = previousPage;
+            }
+        }
+
+#ifdef WITH_THIRD_CHANCE
+        if (IS_THIRD(policy)){
+            // until the queue fills up again the hand stays on the head
+            queue->hand = queue->head;
+        }
+#endif
+    }
+
+    queue->size --;
+    count_advice(queue, page->advice, -1);
+    page->next = NULL;
+
+    return page;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : queue_evict
+// Description  : Removes the page the queue's policy would evict next, so that
+//                  its frame can be handed to another queue
+//                  
+//
+// Inputs       : QUEUE* queue - queue instance to evict from
+//              : void* vm_ptr - pointer to the start of the queue's virtual memory
+//              : int pageSize - the size of memory for each page
+//              : int policy - the virtual memory manager's policy, either FIFO or THIRD
+// Outputs      : Returns the evicted page
+
+PAGE* queue_evict(QUEUE* queue, void* vm_ptr, int pageSize, int policy){
+    PAGE* evictedPage = NULL;
+
+    if (IS_FIFO(policy)){
+        evictedPage = find_fifo_page(queue);
+    }
+#ifdef WITH_THIRD_CHANCE
+    else if (queue->size > 1){
+        if (!queue->circular){
+            queue->tail->next = queue->head;
+            queue->circular = true;
+        }
+        evictedPage = find_eviction_page(queue, vm_ptr, pageSize);
+        queue->hand = evictedPage;
+    } else {
+        evictedPage = queue->hand;
+    }
+#endif
+
+    return queue_remove(queue, evictedPage, policy);
+}
+
+
+#ifdef WITH_THIRD_CHANCE
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : open_queue
+// Description  : Breaks a circular queue just behind the hand, turning it into
+//                  a list that starts at the hand
+//                  
+//
+// Inputs       : QUEUE* queue - circular queue instance
+// Outputs      : None
+
+void open_queue(QUEUE* queue){
+    queue->tail = find_previous_page(queue->hand);
+    queue->tail->next = NULL;
+    queue->head = queue->hand;
+    queue->circular = false;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Function     : find_eviction_page
@@ -137,9 +302,15 @@ PAGE* queue_insert(QUEUE* queue, PAGE* newPage, int numFrames, void* vm_ptr, int
 
 PAGE* find_eviction_page(QUEUE* queue, void* vm_ptr, int pageSize){
     PAGE* currentPage = queue->hand;
+    // hot pages are skipped unless every page is hot
+    bool skipHot = (queue->hotPages > 0) && (queue->hotPages < queue->size);
 
     while (true){
-        if (currentPage->referenced == 1){ // same case for modified == 1 or 0
+        if (skipHot && (currentPage->advice == MM_ADV_HOT)){
+            // pages advised as hot are passed over by the hand, keeping their bits
+            currentPage = currentPage->next;
+            continue;
+        } else if (currentPage->referenced == 1){ // same case for modified == 1 or 0
             // if the page was referenced, reset the bit and set protection to none
             // to catch any future references
             currentPage->referenced = 0;
@@ -162,8 +333,82 @@ PAGE* find_eviction_page(QUEUE* queue, void* vm_ptr, int pageSize){
 
     return currentPage;
 }
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : find_fifo_page
+// Description  : Given a FIFO queue, find the oldest page that is not advised
+//                  as hot. If every page is hot, the head is returned.
+//                  
+//
+// Inputs       : QUEUE* queue - queue instance
+// Outputs      : Returns the page to be evicted
+
+PAGE* find_fifo_page(QUEUE* queue){
+    PAGE* currentPage = queue->head;
+
+    while (currentPage != NULL){
+        if (currentPage->advice != MM_ADV_HOT){
+            return currentPage;
+        }
+        currentPage = currentPage->next;
+    }
+
+    return queue->head;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : find_sequential_page
+// Description  : Finds the oldest page advised as sequential whose pageNum is
+//                  below the faulting page, i.e. one the scan has already passed
+//                  
+//
+// Inputs       : QUEUE* queue - queue instance
+//              : int pageNum - pageNum of the faulting page
+//              : int policy - the virtual memory manager's policy, either FIFO or THIRD
+// Outputs      : Returns the page to be evicted, null if there is none
+
+PAGE* find_sequential_page(QUEUE* queue, int pageNum, int policy){
+    PAGE* currentPage = queue_start(queue, policy);
+
+    for (int i = 0; i < queue->size; i++){
+        if ((currentPage->advice == MM_ADV_SEQUENTIAL) && (currentPage->pageNum < pageNum)){
+            return currentPage;
+        }
+        currentPage = currentPage->next;
+    }
+
+    return NULL;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : count_advice
+// Description  : Keeps the queue's counts of pages advised as sequential or hot,
+//                  called whenever a page enters or leaves the queue or its advice
+//                  changes
+//                  
+//
+// Inputs       : QUEUE* queue - queue instance
+//              : int advice - advice of the page
+//              : int change - 1 if the page is added, -1 if it is removed
+// Outputs      : None
+
+void count_advice(QUEUE* queue, int advice, int change){
+    if (advice == MM_ADV_SEQUENTIAL){
+        queue->sequentialPages += change;
+    } else if (advice == MM_ADV_HOT){
+        queue->hotPages += change;
+    }
+}
 
 
+#ifdef WITH_THIRD_CHANCE
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Function     : find_previous_page
@@ -183,6 +428,28 @@ PAGE* find_previous_page(PAGE* page){
 
     return currentPage;
 }
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : queue_start
+// Description  : Returns the page a policy starts scanning the queue from,
+//                  the head for FIFO and the hand for third chance
+//                  
+//
+// Inputs       : QUEUE* queue - queue instance
+//              : int policy - the virtual memory manager's policy, either FIFO or THIRD
+// Outputs      : Returns the first page to scan
+
+PAGE* queue_start(QUEUE* queue, int policy){
+#ifdef WITH_THIRD_CHANCE
+    if (IS_THIRD(policy)){
+        return queue->hand;
+    }
+#endif
+    return queue->head;
+}
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -201,26 +468,16 @@ PAGE* find_in_queue(QUEUE* queue, int pageNum, int policy){
         return NULL;
     }
     
-    // For FIFO policy, if page is head, return true
-    if ((policy == MM_FIFO) && (queue->head->pageNum == pageNum)) {
-        return queue->head;
-    }
-
-    // If page is hand, return true
-    if ((policy == MM_THIRD) && (queue->hand->pageNum == pageNum)) {
-        return queue->hand;
+    // If page is the head for FIFO policy or the hand for THIRD, return it
+    PAGE* startPage = queue_start(queue, policy);
+    if (startPage->pageNum == pageNum) {
+        return startPage;
     }
 
-    PAGE* currentPage;
-
-    if (policy == MM_FIFO){
-        currentPage = queue->head;
-    } else if (policy == MM_THIRD){
-        currentPage = queue->hand;
-    }
+    PAGE* currentPage = startPage;
     
     // Traverse queue until we find the page
-    while((currentPage->next != NULL) && (currentPage->next != queue->hand)){
+    while((currentPage->next != NULL) && (currentPage->next != startPage)){
         if(currentPage->next->pageNum == pageNum) {
             return currentPage->next;
         }
@@ -232,6 +489,434 @@ PAGE* find_in_queue(QUEUE* queue, int pageNum, int policy){
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : init_arbiter
+// Description  : Initializes a frame arbiter sharing numFrames between its regions.
+//                  Replacement starts out global across the regions.
+//                  
+//
+// Inputs       : int numFrames - number of physical frames to share
+// Outputs      : Returns the created arbiter, null if failed
+
+ARBITER* init_arbiter(int numFrames){
+    ARBITER* arbiter = (ARBITER*) malloc(sizeof(ARBITER));
+    if(arbiter) {
+        arbiter->regions = NULL;
+        arbiter->numRegions = 0;
+        arbiter->scope = MM_GLOBAL;
+        arbiter->numFrames = numFrames;
+        arbiter->usedFrames = 0;
+        arbiter->freeFrames = (int*) malloc(sizeof(int) * numFrames);
+        arbiter->numFreeFrames = 0;
+        arbiter->recentFaults = 0;
+        return arbiter;
+    } else {
+        return NULL;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : arbiter_add_region
+// Description  : Adds a managed region to the arbiter and recomputes the quotas
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+//              : void* vm_ptr - pointer to the start of the region's virtual memory
+//              : int numPages - number of virtual pages in the region
+//              : int minFrames - frames the region is guaranteed to keep
+//              : int weight - the region's share of the frames relative to the others
+// Outputs      : Returns the created region, null if failed
+
+REGION* arbiter_add_region(ARBITER* arbiter, void* vm_ptr, int numPages, int minFrames, int weight){
+    REGION* region = (REGION*) malloc(sizeof(REGION));
+    REGION** regions = (REGION**) realloc(arbiter->regions, sizeof(REGION*) * (arbiter->numRegions + 1));
+    int numClusters = (numPages + SWAP_CLUSTER_PAGES - 1) / SWAP_CLUSTER_PAGES;
+    if((region == NULL) || (regions == NULL)) {
+        free(region);
+        return NULL;
+    }
+
+    region->vm_ptr = vm_ptr;
+    region->numPages = numPages;
+    region->pageAdvice = (int*) calloc(numPages, sizeof(int)); // no access hints until mm_advise
+    region->swapState = (int*) calloc(numPages, sizeof(int));  // no page is in swap yet
+    region->swapClusters = (int*) malloc(sizeof(int) * numClusters);
+    for (int i = 0; i < numClusters; i++){
+        region->swapClusters[i] = -1; // Set when a page of the cluster is first written to swap
+    }
+    region->queue = init_queue();
+    region->minFrames = minFrames;
+    region->weight = weight;
+    region->quota = 0; // Set when the quotas are updated
+    region->faults = 0;
+    region->writebacks = 0;
+    region->recentFaults = 0;
+
+    arbiter->regions = regions;
+    arbiter->regions[arbiter->numRegions] = region;
+    arbiter->numRegions ++;
+    update_quotas(arbiter);
+
+    return region;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : update_quotas
+// Description  : Splits the frames into per-region quotas. Every region gets its
+//                  min guarantee and at least one frame, the remaining frames
+//                  are split by weight and frames left over from rounding go to
+//                  the oldest regions.
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+// Outputs      : None
+
+void update_quotas(ARBITER* arbiter){
+    int totalMin = 0;
+    int totalWeight = 0;
+    int spareFrames;
+    int leftoverFrames;
+    int i;
+
+    for (i = 0; i < arbiter->numRegions; i++){
+        totalMin += quota_floor(arbiter->regions[i]);
+        totalWeight += arbiter->regions[i]->weight;
+    }
+
+    spareFrames = arbiter->numFrames - totalMin;
+    leftoverFrames = spareFrames;
+    for (i = 0; i < arbiter->numRegions; i++){
+        REGION* region = arbiter->regions[i];
+        region->quota = quota_floor(region) + (spareFrames * region->weight) / totalWeight;
+        leftoverFrames -= region->quota - quota_floor(region);
+    }
+
+    for (i = 0; (i < arbiter->numRegions) && (leftoverFrames > 0); i++){
+        arbiter->regions[i]->quota ++;
+        leftoverFrames --;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : quota_floor
+// Description  : Returns the smallest quota a region can be given, its min
+//                  guarantee but at least one frame so it can always fault a page in
+//                  
+//
+// Inputs       : REGION* region - region instance
+// Outputs      : Returns the quota floor
+
+int quota_floor(REGION* region){
+    return (region->minFrames > 1) ? region->minFrames : 1;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : find_region
+// Description  : Finds the region containing a given address
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+//              : void* addr - the address to look up
+//              : int pageSize - the size of memory for each page
+// Outputs      : Returns the region, null if no region contains the address
+
+REGION* find_region(ARBITER* arbiter, void* addr, int pageSize){
+    for (int i = 0; i < arbiter->numRegions; i++){
+        REGION* region = arbiter->regions[i];
+        if (((char*)addr >= (char*)region->vm_ptr) &&
+            ((char*)addr < (char*)region->vm_ptr + (region->numPages * pageSize))){
+            return region;
+        }
+    }
+
+    return NULL;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : take_frame
+// Description  : Takes a free physical frame. Released frames are reused first,
+//                  otherwise frames are handed out in order.
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+// Outputs      : Returns the frame number
+
+int take_frame(ARBITER* arbiter){
+    int frameNum;
+
+    if (arbiter->numFreeFrames > 0){
+        arbiter->numFreeFrames --;
+        frameNum = arbiter->freeFrames[arbiter->numFreeFrames];
+    } else {
+        // With no released frames, frames 0 to usedFrames - 1 are all in use
+        frameNum = arbiter->usedFrames;
+    }
+    arbiter->usedFrames ++;
+
+    return frameNum;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : release_frame
+// Description  : Returns a physical frame to the free frames
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+//              : int frameNum - the frame being released
+// Outputs      : None
+
+void release_frame(ARBITER* arbiter, int frameNum){
+    arbiter->freeFrames[arbiter->numFreeFrames] = frameNum;
+    arbiter->numFreeFrames ++;
+    arbiter->usedFrames --;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : region_frame_limit
+// Description  : Returns how many frames a region may hold without evicting.
+//                  Global replacement lets it use any free frame, local
+//                  replacement only the free frames up to its quota.
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+//              : REGION* region - the region that needs a frame
+// Outputs      : Returns the frame limit
+
+int region_frame_limit(ARBITER* arbiter, REGION* region){
+    int limit = region->queue->size + (arbiter->numFrames - arbiter->usedFrames);
+
+    if ((arbiter->scope == MM_LOCAL) && (limit > region->quota)){
+        limit = (region->quota > region->queue->size) ? region->quota : region->queue->size;
+        // a region holding no frames may always take a free one
+        if (limit == 0){
+            limit = 1;
+        }
+    }
+
+    return limit;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : find_victim_region
+// Description  : Picks the region that gives up a frame for a fault in the
+//                  given region.
+//                  Local replacement: a region at its quota replaces its own
+//                  pages, one below it takes from the region furthest over quota.
+//                  Global replacement: a noisy region replaces its own pages,
+//                  otherwise the cheapest region above its min guarantee is used.
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+//              : REGION* region - the region that needs a frame
+// Outputs      : Returns the region to evict a page from, null if no region holds a frame
+
+REGION* find_victim_region(ARBITER* arbiter, REGION* region){
+    REGION* victimRegion = NULL;
+    REGION* otherRegion;
+    long victimCost = 0;
+    long cost;
+    int victimExcess = 0;
+    int i;
+
+    if (arbiter->scope == MM_LOCAL){
+        if ((region->queue->size >= region->quota) && (region->queue->size > 0)){
+            return region;
+        }
+        for (i = 0; i < arbiter->numRegions; i++){
+            otherRegion = arbiter->regions[i];
+            if ((otherRegion != region) && (otherRegion->queue->size - otherRegion->quota > victimExcess)){
+                victimRegion = otherRegion;
+                victimExcess = otherRegion->queue->size - otherRegion->quota;
+            }
+        }
+        if ((victimRegion == NULL) && (region->queue->size > 0)){
+            victimRegion = region;
+        }
+    } else {
+        if (region->queue->size > 0){
+            if (is_noisy_region(arbiter, region)){
+                return region;
+            }
+            victimRegion = region;
+            victimCost = eviction_cost(region);
+        }
+        for (i = 0; i < arbiter->numRegions; i++){
+            otherRegion = arbiter->regions[i];
+            if ((otherRegion == region) || (otherRegion->queue->size <= otherRegion->minFrames)){
+                continue;
+            }
+            cost = eviction_cost(otherRegion);
+            if ((victimRegion == NULL) || (cost < victimCost)){
+                victimRegion = otherRegion;
+                victimCost = cost;
+            }
+        }
+    }
+
+    if (victimRegion == NULL){
+        // the region holds no frames and none can be taken by the rules above,
+        // so take from the region holding the most frames. Empty regions have nothing to give.
+        for (i = 0; i < arbiter->numRegions; i++){
+            otherRegion = arbiter->regions[i];
+            if ((otherRegion->queue->size > 0) &&
+                ((victimRegion == NULL) || (otherRegion->queue->size > victimRegion->queue->size))){
+                victimRegion = otherRegion;
+            }
+        }
+    }
+
+    return victimRegion;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : eviction_cost
+// Description  : Returns the cost of taking a frame away from a region. It grows
+//                  with the region's weight per frame held and with the share
+//                  of its pages that would need a write-back.
+//                  
+//
+// Inputs       : REGION* region - region instance holding at least one frame
+// Outputs      : Returns the cost
+
+long eviction_cost(REGION* region){
+    QUEUE* queue = region->queue;
+#ifdef WITH_THIRD_CHANCE
+    // Only third chance queues have a hand, which is always a valid start
+    PAGE* currentPage = (queue->hand != NULL) ? queue->hand : queue->head;
+#else
+    PAGE* currentPage = queue->head;
+#endif
+    long dirtyPages = 0;
+    long size = queue->size;
+
+    for (int i = 0; i < queue->size; i++){
+        dirtyPages += currentPage->modified;
+        currentPage = currentPage->next;
+    }
+
+    return (COST_SCALE * region->weight * (size + WRITEBACK_COST * dirtyPages)) / (size * size);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : is_noisy_region
+// Description  : Returns whether a region already holds its fair share of the
+//                  frames and still takes a larger share of the recent faults
+//                  than its weight allows. Such a region only replaces its own pages.
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+//              : REGION* region - region instance
+// Outputs      : Returns true if the region is noisy
+
+bool is_noisy_region(ARBITER* arbiter, REGION* region){
+    int totalWeight = 0;
+
+    for (int i = 0; i < arbiter->numRegions; i++){
+        totalWeight += arbiter->regions[i]->weight;
+    }
+
+    if (region->queue->size * totalWeight < arbiter->numFrames * region->weight){
+        return false;
+    }
+
+    return region->recentFaults * totalWeight > arbiter->recentFaults * region->weight;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : arbiter_insert
+// Description  : Inserts a page into a region. The page takes a free frame if
+//                  the region may use one, otherwise a page is evicted from the
+//                  region picked by find_victim_region and its frame is reused.
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+//              : REGION* region - region the page belongs to
+//              : PAGE* newPage - page instance to be inserted
+//              : REGION** evictedRegion - set to the region of the evicted page
+//              : int pageSize - the size of memory for each page
+//              : int policy - the virtual memory manager's policy, either FIFO or THIRD
+// Outputs      : Returns the evicted page if one was evicted, null otherwise
+
+PAGE* arbiter_insert(ARBITER* arbiter, REGION* region, PAGE* newPage, REGION** evictedRegion, int pageSize, int policy){
+    PAGE* evictedPage;
+    REGION* victimRegion;
+    int limit = region_frame_limit(arbiter, region);
+
+    *evictedRegion = NULL;
+
+    if (region->queue->size < limit){
+        // a free frame is available to the region
+        newPage->frameNum = take_frame(arbiter);
+        queue_insert(region->queue, newPage, limit, region->vm_ptr, pageSize, policy);
+        return NULL;
+    }
+
+    victimRegion = find_victim_region(arbiter, region);
+    if (victimRegion == region){
+        evictedPage = queue_insert(region->queue, newPage, region->queue->size, region->vm_ptr, pageSize, policy);
+    } else {
+        // move a frame from the victim region over to this region
+        evictedPage = queue_evict(victimRegion->queue, victimRegion->vm_ptr, pageSize, policy);
+        newPage->frameNum = evictedPage->frameNum;
+        queue_insert(region->queue, newPage, region->queue->size + 1, region->vm_ptr, pageSize, policy);
+    }
+
+    victimRegion->writebacks += evictedPage->modified;
+    *evictedRegion = victimRegion;
+
+    return evictedPage;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : account_fault
+// Description  : Records a page-in for a region. Every FAULT_WINDOW page-ins the
+//                  recent fault counts are halved so they follow current behavior.
+//                  
+//
+// Inputs       : ARBITER* arbiter - arbiter instance
+//              : REGION* region - region the page-in happened in
+// Outputs      : None
+
+void account_fault(ARBITER* arbiter, REGION* region){
+    region->faults ++;
+    region->recentFaults ++;
+    arbiter->recentFaults ++;
+
+    if (arbiter->recentFaults >= FAULT_WINDOW){
+        arbiter->recentFaults = 0;
+        for (int i = 0; i < arbiter->numRegions; i++){
+            arbiter->regions[i]->recentFaults /= 2;
+            arbiter->recentFaults += arbiter->regions[i]->recentFaults;
+        }
+    }
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Function     : get_fault_type
@@ -259,22 +944,25 @@ int get_fault_type(ucontext_t* context, QUEUE* queue, PAGE* referencedPage, int
         }
         // Else, it is in our queue
         else {
-            if ((policy == MM_THIRD) && (referencedPage->canWrite)){
+            faultType = 2;
+#ifdef WITH_THIRD_CHANCE
+            if (IS_THIRD(policy) && (referencedPage->canWrite)){
                 faultType = 4;
-            } else {
-                faultType = 2;
             }
+#endif
         }
     }
 
     // If fault was a read
     else if(faultType == 0) {
-        if((policy == MM_FIFO) || (referencedPage == NULL)){
+        if(IS_FIFO(policy) || (referencedPage == NULL)){
             faultType = 0;
         }
+#ifdef WITH_THIRD_CHANCE
         else if (referencedPage->canRead || referencedPage->canWrite){
             faultType = 3;
         }
+#endif
     }
     
     // In case something goes wrong
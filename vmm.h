@@ -7,6 +7,35 @@
 
 typedef struct queue_struct QUEUE;
 typedef struct page_struct PAGE;
+typedef struct region_struct REGION;
+typedef struct arbiter_struct ARBITER;
+
+// Policy-specialized builds (make fifo, make third) set MM_POLICY to the policy's
+// number. Every policy check then becomes a constant the compiler folds away and
+// pages and queues only carry the fields that policy uses.
+#if defined(MM_POLICY) && (MM_POLICY != 1) && (MM_POLICY != 2)
+#error "MM_POLICY must be 1 (FIFO) or 2 (third chance)"
+#endif
+
+#ifdef MM_POLICY
+#define IS_FIFO(policy) (MM_POLICY == MM_FIFO)
+#define IS_THIRD(policy) (MM_POLICY == MM_THIRD)
+#else
+#define IS_FIFO(policy) ((policy) == MM_FIFO)
+#define IS_THIRD(policy) ((policy) == MM_THIRD)
+#endif
+
+// Third chance state is only kept by builds that can run the third chance policy
+#if !defined(MM_POLICY) || (MM_POLICY == 2)
+#define WITH_THIRD_CHANCE
+#endif
+
+// Weight of a region's eviction cost, scaled so integer division keeps precision
+#define COST_SCALE 1024
+// Extra cost of evicting a dirty page relative to a clean one
+#define WRITEBACK_COST 2
+// Number of page-ins after which the recent fault counts are halved
+#define FAULT_WINDOW 256
 
 enum fault_type
 {
@@ -22,8 +51,13 @@ struct queue_struct
 {
     PAGE* head;
     PAGE* tail;
-    PAGE* hand;
     int size;
+    int sequentialPages; // pages advised as sequential, so evictions skip the scan when there are none
+    int hotPages;        // pages advised as hot
+#ifdef WITH_THIRD_CHANCE
+    PAGE* hand;
+    bool circular;
+#endif
 };
 
 
@@ -31,15 +65,48 @@ struct page_struct
 {
     int frameNum;
     int pageNum;
-    unsigned int referenced : 1;
     unsigned int modified : 1;
+#ifdef WITH_THIRD_CHANCE
+    unsigned int referenced : 1;
     bool canRead;
     bool canWrite;
     bool thirdChanceTaken;
+#endif
+    int advice;
     PAGE* next;
 };
 
 
+struct region_struct
+{
+    void* vm_ptr;
+    int numPages;
+    int* pageAdvice;
+    int* swapState;
+    int* swapClusters;
+    QUEUE* queue;
+    int minFrames;
+    int weight;
+    int quota;
+    int faults;
+    int writebacks;
+    int recentFaults;
+};
+
+
+struct arbiter_struct
+{
+    REGION** regions;
+    int numRegions;
+    int scope;
+    int numFrames;
+    int usedFrames;
+    int* freeFrames;
+    int numFreeFrames;
+    int recentFaults;
+};
+
+
 QUEUE* init_queue();
     // Initializes a queue
 
@@ -49,15 +116,79 @@ PAGE* init_page(int pageNum);
 PAGE* queue_insert(QUEUE* queue, PAGE* newPage, int numFrames, void* vm_ptr, int pageSize, int policy);
     // Inserts a given page into the queue, evicting a page if needed
 
+PAGE* queue_remove(QUEUE* queue, PAGE* page, int policy);
+    // Removes a given page from the queue
+
+PAGE* queue_evict(QUEUE* queue, void* vm_ptr, int pageSize, int policy);
+    // Removes the page the queue's policy would evict next, freeing its frame for another queue
+
+#ifdef WITH_THIRD_CHANCE
+void open_queue(QUEUE* queue);
+    // Breaks a circular queue just behind the hand, turning it into a list starting at the hand
+
 PAGE* find_eviction_page(QUEUE* queue, void* vm_ptr, int pageSize);
     // Given a circular queue, find the next page to be evicted following the third chance policy
+#endif
+
+PAGE* find_fifo_page(QUEUE* queue);
+    // Given a FIFO queue, find the oldest page that is not advised as hot
+
+PAGE* find_sequential_page(QUEUE* queue, int pageNum, int policy);
+    // Finds a page advised as sequential that a scan has already passed
+
+void count_advice(QUEUE* queue, int advice, int change);
+    // Adds change to the queue's count of pages with the given advice
 
+#ifdef WITH_THIRD_CHANCE
 PAGE* find_previous_page(PAGE* page);
     // Given a page in a circular queue, find the previous page in the cycle that points to the given page
+#endif
+
+PAGE* queue_start(QUEUE* queue, int policy);
+    // Returns the page a policy starts scanning the queue from
 
 PAGE* find_in_queue(QUEUE* queue, int pageNum, int policy);
     // finds a page in a queue given its pageNum
 
+ARBITER* init_arbiter(int numFrames);
+    // Initializes a frame arbiter sharing numFrames between its regions
+
+REGION* arbiter_add_region(ARBITER* arbiter, void* vm_ptr, int numPages, int minFrames, int weight);
+    // Adds a managed region to the arbiter and recomputes the quotas
+
+void update_quotas(ARBITER* arbiter);
+    // Splits the frames into per-region quotas by min guarantee and weight
+
+int quota_floor(REGION* region);
+    // Returns the smallest quota a region can be given, its min guarantee but at least one frame
+
+REGION* find_region(ARBITER* arbiter, void* addr, int pageSize);
+    // Finds the region containing a given address
+
+int take_frame(ARBITER* arbiter);
+    // Takes a free physical frame
+
+void release_frame(ARBITER* arbiter, int frameNum);
+    // Returns a physical frame to the free frames
+
+int region_frame_limit(ARBITER* arbiter, REGION* region);
+    // Returns how many frames a region may hold without evicting
+
+REGION* find_victim_region(ARBITER* arbiter, REGION* region);
+    // Picks the region that gives up a frame for a fault in the given region
+
+long eviction_cost(REGION* region);
+    // Returns the cost of taking a frame away from a region
+
+bool is_noisy_region(ARBITER* arbiter, REGION* region);
+    // Returns whether a region faults more than its weight and fair share allow
+
+PAGE* arbiter_insert(ARBITER* arbiter, REGION* region, PAGE* newPage, REGION** evictedRegion, int pageSize, int policy);
+    // Inserts a page into a region, evicting a page from some region if needed
+
+void account_fault(ARBITER* arbiter, REGION* region);
+    // Records a page-in for a region
+
 int get_fault_type(ucontext_t* context, QUEUE* queue, PAGE* referencedPage, int policy);
     // Returns the type of fault that occured
 